@@ -11,7 +11,12 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
+#include "occlusionCuller.h"
+#include "objLoader.h"
+
 #include <iostream>
+#include <fstream>
+#include <chrono>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -19,6 +24,11 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window, float&, float&, float&, float&, float&, float&, float&, float&, float&, float&, float&, float&, float&, float&, unsigned int&, float&, float&);
 unsigned int loadCubemap(vector<std::string> faces);
 unsigned int loadTexture(const char* path);
+void writeSyntheticObj(const string& path, size_t targetBytes);
+void benchmarkObjLoaders();
+bool loadClipControl();
+glm::mat4 reverseInfinitePerspective(float fovy, float aspect, float zNear);
+void setupLargeWorldFramebuffer(unsigned int& fbo, unsigned int& colorBuffer, unsigned int& depthBuffer, int width, int height);
 
 // settings
 const unsigned int SCR_WIDTH = 1200;
@@ -32,10 +42,23 @@ bool firstMouse = true;
 
 // timing
 float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+double lastFrame = 0.0; // double so frame times stay exact in multi-day sessions
 //glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-int main()
+// large-world mode (L to toggle, or start with --large-world): bodies are placed relative to the camera in double
+// precision and drawn with a reverse-Z infinite far plane
+bool largeWorldMode = false;
+glm::dvec3 cameraWorldPos(0.0); // camera position in large-world mode, camera.Position is moved into it every frame
+
+// glClipControl is core in GL 4.5 and not part of the 3.3 loader, so it is looked up by hand
+#ifndef GL_ZERO_TO_ONE
+#define GL_NEGATIVE_ONE_TO_ONE 0x935E
+#define GL_ZERO_TO_ONE 0x935F
+#endif
+typedef void (APIENTRYP ClipControlProc)(GLenum origin, GLenum depth);
+ClipControlProc clipControl = NULL;
+
+int main(int argc, char** argv)
 {
     // glfw: initialize and configure
     glfwInit();
@@ -70,6 +93,16 @@ int main()
         return -1;
     }
 
+    // --obj-benchmark: compare the Assimp Model constructor with the native OBJ loader and exit
+    if (argc > 1 && string(argv[1]) == "--obj-benchmark")
+    {
+        benchmarkObjLoaders();
+        glfwTerminate();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--large-world")
+        largeWorldMode = true;
+
     // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
     //stbi_set_flip_vertically_on_load(true);
 
@@ -81,8 +114,8 @@ int main()
     Shader lightingShader("cubesLightingShader.vs", "cubesLightingShader.fs");
     Shader skyboxShader("skyboxShader.vs", "skyboxShader.fs");
 
-    // load models
-    Model planetModel(FileSystem::getPath("resources/planet/planet.obj"));
+    // load models (native parser, see objLoader.h; Model goes through Assimp on a single thread)
+    ObjModel planetModel(FileSystem::getPath("resources/planet/planet.obj"));
     
     ////////  CUBES STUFF
     float vertices[] = {
@@ -227,13 +260,14 @@ int main()
 
     // render loop
     ////////////////////////
-    float planetAngle = 0.0f;
-    float cube1Angle = 0.0f;
-    float cube2Angle = 0.0f;
-    float cube3Angle = 0.0f;
-    float cube4Angle = 0.0f;
-    float cube5Angle = 0.0f;
-    float cube6Angle = 0.0f;
+    // body state is kept in double: per-frame increments around 1e-6 fall below float resolution once the angles grow
+    double planetAngle = 0.0;
+    double cube1Angle = 0.0;
+    double cube2Angle = 0.0;
+    double cube3Angle = 0.0;
+    double cube4Angle = 0.0;
+    double cube5Angle = 0.0;
+    double cube6Angle = 0.0;
     float planetSpeed = 0.000002f;
     float cube1Speed = 0.000001f;
     float cube2Speed = 0.000001f;
@@ -241,13 +275,13 @@ int main()
     float cube4Speed = 0.000011f;
     float cube5Speed = -0.000009f;
     float cube6Speed = 0.000007f;
-    float planetSpin = 0.0f;
-    float cube1Spin = 0.0f;
-    float cube2Spin = 0.0f;
-    float cube3Spin = 0.0f;
-    float cube4Spin = 0.0f;
-    float cube5Spin = 0.0f;
-    float cube6Spin = 0.0f;
+    double planetSpin = 0.0;
+    double cube1Spin = 0.0;
+    double cube2Spin = 0.0;
+    double cube3Spin = 0.0;
+    double cube4Spin = 0.0;
+    double cube5Spin = 0.0;
+    double cube6Spin = 0.0;
     float planetSpinSpeed = 0.0000f;
     float cube1SpinSpeed = 0.000015f;
     float cube2SpinSpeed = 0.000018f;
@@ -255,195 +289,281 @@ int main()
     float cube4SpinSpeed = 0.0001f;
     float cube5SpinSpeed = 0.00017f;
     float cube6SpinSpeed = 0.00008f;
-    float X = 0.0f;
-    float Z = 0.0f;
+    double X = 0.0;
+    double Z = 0.0;
     float viewX = 0.0f;
     float viewY = 0.0f;
     /////////////////////////
+    //////////////////////////////////////////////////////////////        OCCLUSION CULLING STUFF
+    // body 0 is the planet, bodies 1-6 are the cubes
+    const int BODY_COUNT = 7;
+    glm::mat4 bodyModels[BODY_COUNT];
+    bool bodyVisible[BODY_COUNT];
+    int lastCulledBodies = -1;
+    OcclusionCuller occlusionCuller;
+    // planet.obj is a sphere of radius ~2.6 centered at (0, 1.05, 0); the proxy uses the smallest radius so it stays inside the mesh
+    // the cubes use their exact box; RenderOccluder shrinks every proxy by a culler pixel before drawing it
+    vector<glm::vec3> planetProxyVertices, cubeProxyVertices;
+    vector<unsigned int> planetProxyIndices, cubeProxyIndices;
+    OcclusionCuller::MakeSphereProxy(glm::vec3(0.0f, 1.05f, 0.0f), 2.6f, 12, 8, planetProxyVertices, planetProxyIndices);
+    OcclusionCuller::MakeBoxProxy(glm::vec3(-0.5f), glm::vec3(0.5f), cubeProxyVertices, cubeProxyIndices);
+    glm::vec3 planetBoxMin(-2.61f, -1.56f, -2.61f);
+    glm::vec3 planetBoxMax(2.61f, 3.66f, 2.61f);
+    ////////////////////////////////////////////////////////       OCCLUSION CULLING STUFF END
+    //////////////////////////////////////////////////////////////        LARGE WORLD STUFF
+    // reverse-Z needs glClipControl and a float depth buffer, which the default framebuffer doesn't have, so the
+    // scene is drawn into an offscreen framebuffer and blitted. Without clip control only the far plane is removed.
+    bool reverseZ = loadClipControl();
+    bool largeWorldActive = false; // the mode the GL state is currently set up for
+    unsigned int largeWorldFBO = 0, largeWorldColor = 0, largeWorldDepth = 0;
+    int largeWorldWidth = 0, largeWorldHeight = 0;
+    ////////////////////////////////////////////////////////       LARGE WORLD STUFF END
     while (!glfwWindowShouldClose(window))
     {
         // per-frame time logic
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
+        double currentFrame = glfwGetTime();
+        deltaTime = (float)(currentFrame - lastFrame);
         lastFrame = currentFrame;
 
         // input
         processInput(window, planetSpeed, cube1Speed, cube2Speed, cube3Speed, cube4Speed, cube5Speed, cube6Speed, planetSpinSpeed, cube1SpinSpeed, cube2SpinSpeed, cube3SpinSpeed, cube4SpinSpeed, cube5SpinSpeed, cube6SpinSpeed, diffuseMap, viewX, viewY);
 
-        // render
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // don't forget to enable shader before setting uniforms
-        planetShader.use();
+        // switch large-world mode on or off
+        if (largeWorldMode != largeWorldActive)
+        {
+            if (largeWorldMode)
+            {
+                cameraWorldPos = glm::dvec3(camera.Position);
+                camera.Position = glm::vec3(0.0f);
+            }
+            else
+                camera.Position = glm::vec3(cameraWorldPos);
+            if (reverseZ)
+            {
+                clipControl(GL_LOWER_LEFT, largeWorldMode ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE);
+                glClearDepth(largeWorldMode ? 0.0 : 1.0);
+            }
+            largeWorldActive = largeWorldMode;
+            cout << "Large-world mode " << (largeWorldMode ? "on" : "off") << endl;
+        }
+        // keep the float camera at the origin, its movement this frame goes into the double position
+        if (largeWorldMode)
+        {
+            cameraWorldPos += glm::dvec3(camera.Position);
+            camera.Position = glm::vec3(0.0f);
+        }
+        bool reversedDepth = largeWorldMode && reverseZ;
 
-        // view/projection transformations
-        planetShader.setVec3("objectColor", 1.0f, 1.0f, 1.0f);
-        planetShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
-        planetShader.setVec3("lightPos", 0.0f, 0.0f, 0.0f);
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 projection;
+        if (!largeWorldMode)
+            projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        else if (reverseZ)
+            projection = reverseInfinitePerspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f);
+        else
+            projection = glm::infinitePerspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f);
         glm::mat4 view = camera.GetViewMatrix();
         view = glm::rotate(view, viewX, glm::vec3(1, 0, 0));
         view = glm::rotate(view, viewY, glm::vec3(0, 1, 0));
-        planetShader.setMat4("projection", projection);
-        planetShader.setMat4("view", view);
 
-        glm::mat4 model = glm::mat4(1.0f);
+        // bodies are positioned in double precision relative to eye and only then converted to float;
+        // outside large-world mode eye is the origin and this is the same as drawing in world space
+        glm::dvec3 eye(0.0);
+        if (largeWorldMode)
+        {
+            // view is lookAt(origin) * rotation, so in the frame the bodies are placed in the camera is at inverse(rotation) * cameraWorldPos
+            glm::dmat4 rotation = glm::rotate(glm::dmat4(1.0), (double)viewX, glm::dvec3(1, 0, 0));
+            rotation = glm::rotate(rotation, (double)viewY, glm::dvec3(0, 1, 0));
+            eye = glm::transpose(glm::dmat3(rotation)) * cameraWorldPos;
+        }
+        glm::dmat4 toEye = glm::translate(glm::dmat4(1.0), -eye);
+
+        glm::dmat4 model = glm::dmat4(1.0);
 
         /////////////////////////////////
         planetAngle += planetSpeed;
         planetSpin += planetSpinSpeed;
         X = 2 * sin(planetAngle);
         Z = 2 * cos(planetAngle);
-        model = glm::translate(model, glm::vec3(X, 0, Z)); // Move to the correct position in the planet's orbit
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));	// Scale planet down
-        model = glm::rotate(model, planetSpin, glm::vec3(0, 0, 1));
-        model = glm::rotate(model, 1.57f, glm::vec3(1, 0, 0));
-        planetShader.setMat4("model", model);
-        planetModel.Draw(planetShader);
+        model = glm::translate(model, glm::dvec3(X, 0, Z)); // Move to the correct position in the planet's orbit
+        model = glm::scale(model, glm::dvec3(0.1, 0.1, 0.1));	// Scale planet down
+        model = glm::rotate(model, planetSpin, glm::dvec3(0, 0, 1));
+        model = glm::rotate(model, 1.57, glm::dvec3(1, 0, 0));
+        bodyModels[0] = glm::mat4(toEye * model);
         //undo rotation
-        model = glm::rotate(model, -1.57f, glm::vec3(1, 0, 0));
-        model = glm::rotate(model, -planetSpin, glm::vec3(0, 0, 1));
-        model = glm::scale(model, glm::vec3(2.0f, 2.0f, 2.0f));
+        model = glm::rotate(model, -1.57, glm::dvec3(1, 0, 0));
+        model = glm::rotate(model, -planetSpin, glm::dvec3(0, 0, 1));
+        model = glm::scale(model, glm::dvec3(2.0, 2.0, 2.0));
 
-        glm::vec3 lightPos(X, 0, Z); // Light source is at the center of the planet
+        glm::vec3 lightPos(glm::dvec3(X, 0, Z) - eye); // Light source is at the center of the planet
 
-        // Draw 1st cube
+        // 1st cube
         cube1Angle += cube1Speed;
         cube1Spin += cube1SpinSpeed;
         X = 5 * sin(cube1Angle);
         Z = 5 * cos(cube1Angle);
-        model = glm::translate(model, glm::vec3(X, 0, Z)); // Move to this cube's position
-        model = glm::rotate(model, cube1Spin, glm::vec3(0, 0, 1));
-        //////////////////////////////////////// Draw CUBE
-        lightingShader.use();
-        lightingShader.setVec3("light.position", lightPos);
-        lightingShader.setVec3("viewPos", camera.Position); // light properties
-        lightingShader.setVec3("light.ambient", 0.3f, 0.3f, 0.3f);
-        lightingShader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
-        lightingShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("material.specular", 0.8f, 0.8f, 0.8f); // material properties
-        lightingShader.setFloat("material.shininess", 64.0f);
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0); // bind diffuse map
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glBindVertexArray(cubeVAO); // render the cube
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        //////////////////////////////////////// END DRAW CUBE
-        // Undo transformations to draw next cube independently
-        model = glm::rotate(model, -cube1Spin, glm::vec3(0, 0, 1));
-        model = glm::translate(model, glm::vec3(-X, 0, -Z));
-
-        // Draw 2nd cube
+        model = glm::translate(model, glm::dvec3(X, 0, Z)); // Move to this cube's position
+        model = glm::rotate(model, cube1Spin, glm::dvec3(0, 0, 1));
+        bodyModels[1] = glm::mat4(toEye * model);
+        // Undo transformations to place next cube independently
+        model = glm::rotate(model, -cube1Spin, glm::dvec3(0, 0, 1));
+        model = glm::translate(model, glm::dvec3(-X, 0, -Z));
+
+        // 2nd cube
         cube2Angle += cube2Speed;
         cube2Spin += cube2SpinSpeed;
         X = 7 * sin(cube2Angle);
         Z = 7 * cos(cube2Angle);
-        model = glm::translate(model, glm::vec3(X, X, Z));
-        model = glm::rotate(model, cube2Spin, glm::vec3(1, 0, 0));
-        //////////////////////////////////////// Draw CUBE
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0); // bind diffuse map
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glBindVertexArray(cubeVAO); // render the cube
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        //////////////////////////////////////// END DRAW CUBE
-        model = glm::rotate(model, -cube2Spin, glm::vec3(1, 0, 0));
-        model = glm::translate(model, glm::vec3(-X, -X, -Z));
+        model = glm::translate(model, glm::dvec3(X, X, Z));
+        model = glm::rotate(model, cube2Spin, glm::dvec3(1, 0, 0));
+        bodyModels[2] = glm::mat4(toEye * model);
+        model = glm::rotate(model, -cube2Spin, glm::dvec3(1, 0, 0));
+        model = glm::translate(model, glm::dvec3(-X, -X, -Z));
 
-        // Draw 3rd cube
+        // 3rd cube
         cube3Angle += cube3Speed;
         cube3Spin += cube3SpinSpeed;
         X = 9 * sin(cube3Angle);
         Z = 9 * cos(cube3Angle);
-        model = glm::translate(model, glm::vec3(X, Z, 0)); // Move to this cube's position
-        model = glm::rotate(model, cube3Spin, glm::vec3(1, 1, 1));
-        //////////////////////////////////////// Draw CUBE
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0); // bind diffuse map
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glBindVertexArray(cubeVAO); // render the cube
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        //////////////////////////////////////// END DRAW CUBE
-        model = glm::rotate(model, -cube3Spin, glm::vec3(1, 1, 1));
-        model = glm::translate(model, glm::vec3(-X, -Z, 0));
+        model = glm::translate(model, glm::dvec3(X, Z, 0)); // Move to this cube's position
+        model = glm::rotate(model, cube3Spin, glm::dvec3(1, 1, 1));
+        bodyModels[3] = glm::mat4(toEye * model);
+        model = glm::rotate(model, -cube3Spin, glm::dvec3(1, 1, 1));
+        model = glm::translate(model, glm::dvec3(-X, -Z, 0));
 
-        // Draw 4th cube
+        // 4th cube
         cube4Angle += cube4Speed;
         cube4Spin += cube4SpinSpeed;
         X = 10 * sin(cube4Angle);
         Z = 12.5 * cos(cube4Angle);
-        model = glm::translate(model, glm::vec3(X, Z, Z)); // Move to this cube's position
-        model = glm::rotate(model, cube4Spin, glm::vec3(0, 1, 0));
-        //////////////////////////////////////// Draw CUBE
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0); // bind diffuse map
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glBindVertexArray(cubeVAO); // render the cube
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        //////////////////////////////////////// END DRAW CUBE
-        model = glm::rotate(model, -cube4Spin, glm::vec3(0, 1, 0));
-        model = glm::translate(model, glm::vec3(-X, -Z, -Z));
+        model = glm::translate(model, glm::dvec3(X, Z, Z)); // Move to this cube's position
+        model = glm::rotate(model, cube4Spin, glm::dvec3(0, 1, 0));
+        bodyModels[4] = glm::mat4(toEye * model);
+        model = glm::rotate(model, -cube4Spin, glm::dvec3(0, 1, 0));
+        model = glm::translate(model, glm::dvec3(-X, -Z, -Z));
 
-        // Draw 5th cube
+        // 5th cube
         cube5Angle += cube5Speed;
         cube5Spin += cube5SpinSpeed;
         X = 13.5 * sin(cube5Angle);
         Z = 16 * cos(cube5Angle);
-        model = glm::translate(model, glm::vec3(X, -X, Z)); // Move to this cube's position
-        model = glm::rotate(model, cube5Spin, glm::vec3(6, 9, 1));
-        //////////////////////////////////////// Draw CUBE
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-        lightingShader.setMat4("model", model);
-        glActiveTexture(GL_TEXTURE0); // bind diffuse map
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glBindVertexArray(cubeVAO); // render the cube
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        //////////////////////////////////////// END DRAW CUBE
-        model = glm::rotate(model, -cube5Spin, glm::vec3(6, 9, 1));
-        model = glm::translate(model, glm::vec3(-X, X, -Z));
+        model = glm::translate(model, glm::dvec3(X, -X, Z)); // Move to this cube's position
+        model = glm::rotate(model, cube5Spin, glm::dvec3(6, 9, 1));
+        bodyModels[5] = glm::mat4(toEye * model);
+        model = glm::rotate(model, -cube5Spin, glm::dvec3(6, 9, 1));
+        model = glm::translate(model, glm::dvec3(-X, X, -Z));
 
-        // Draw 6th cube
+        // 6th cube
         cube6Angle += cube6Speed;
         cube6Spin += cube6SpinSpeed;
         X = 16 * sin(cube6Angle);
         Z = 16 * cos(cube6Angle);
-        model = glm::translate(model, glm::vec3(X, 0, Z)); // Move to this cube's position
-        model = glm::rotate(model, cube6Spin, glm::vec3(1, 5, 1));
-        //////////////////////////////////////// Draw CUBE
+        model = glm::translate(model, glm::dvec3(X, 0, Z)); // Move to this cube's position
+        model = glm::rotate(model, cube6Spin, glm::dvec3(1, 5, 1));
+        bodyModels[6] = glm::mat4(toEye * model);
+
+        //////////////////////////////////////// OCCLUSION CULLING
+        // Runs before any GL call of this frame, so it overlaps with the GPU still working on the previous frame.
+        // Every body is both an occluder and an occludee; a body can never hide itself because its proxy
+        // lies inside its own bounding box.
+        occlusionCuller.BeginFrame(projection * view, reversedDepth);
+        occlusionCuller.RenderOccluder(bodyModels[0], planetProxyVertices, planetProxyIndices);
+        for (int i = 1; i < BODY_COUNT; i++)
+            occlusionCuller.RenderOccluder(bodyModels[i], cubeProxyVertices, cubeProxyIndices);
+        occlusionCuller.BuildHierarchy();
+        int culledBodies = 0;
+        for (int i = 0; i < BODY_COUNT; i++)
+        {
+            if (i == 0)
+                bodyVisible[i] = !occlusionCuller.IsOccluded(bodyModels[i], planetBoxMin, planetBoxMax);
+            else
+                bodyVisible[i] = !occlusionCuller.IsOccluded(bodyModels[i], glm::vec3(-0.5f), glm::vec3(0.5f));
+            if (!bodyVisible[i])
+                culledBodies++;
+        }
+        if (culledBodies != lastCulledBodies)
+        {
+            cout << "Occlusion culled " << culledBodies << " of " << BODY_COUNT << " bodies" << endl;
+            lastCulledBodies = culledBodies;
+        }
+        //////////////////////////////////////// OCCLUSION CULLING END
+
+        // render
+        if (reversedDepth)
+        {
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            if (width != largeWorldWidth || height != largeWorldHeight)
+            {
+                setupLargeWorldFramebuffer(largeWorldFBO, largeWorldColor, largeWorldDepth, width, height);
+                largeWorldWidth = width;
+                largeWorldHeight = height;
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, largeWorldFBO);
+        }
+        glDepthFunc(reversedDepth ? GL_GREATER : GL_LESS);
+        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // don't forget to enable shader before setting uniforms
+        planetShader.use();
+
+        // view/projection transformations
+        planetShader.setVec3("objectColor", 1.0f, 1.0f, 1.0f);
+        planetShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+        planetShader.setVec3("lightPos", 0.0f, 0.0f, 0.0f);
+        planetShader.setMat4("projection", projection);
+        planetShader.setMat4("view", view);
+        if (bodyVisible[0])
+        {
+            planetShader.setMat4("model", bodyModels[0]);
+            planetModel.Draw(planetShader);
+        }
+
+        //////////////////////////////////////// Draw CUBES
+        lightingShader.use();
+        lightingShader.setVec3("light.position", lightPos);
+        lightingShader.setVec3("viewPos", camera.Position); // light properties
+        lightingShader.setVec3("light.ambient", 0.3f, 0.3f, 0.3f);
+        lightingShader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
+        lightingShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
+        lightingShader.setVec3("material.specular", 0.8f, 0.8f, 0.8f); // material properties
+        lightingShader.setFloat("material.shininess", 64.0f);
         lightingShader.setMat4("projection", projection);
         lightingShader.setMat4("view", view);
-        lightingShader.setMat4("model", model);
         glActiveTexture(GL_TEXTURE0); // bind diffuse map
         glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glBindVertexArray(cubeVAO); // render the cube
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        //////////////////////////////////////// END DRAW CUBE
-        model = glm::rotate(model, -cube6Spin, glm::vec3(1, 5, 1));
-        model = glm::translate(model, glm::vec3(-X, 0, -Z));
+        glBindVertexArray(cubeVAO);
+        for (int i = 1; i < BODY_COUNT; i++)
+        {
+            if (!bodyVisible[i])
+                continue;
+            lightingShader.setMat4("model", bodyModels[i]);
+            glDrawArrays(GL_TRIANGLES, 0, 36); // render the cube
+        }
+        //////////////////////////////////////// END DRAW CUBES
 
         // draw skybox as last
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
+        glDepthFunc(reversedDepth ? GL_GEQUAL : GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
         skyboxShader.use();
         view = glm::mat4(glm::mat3(camera.GetViewMatrix())); // remove translation from the view matrix
         skyboxShader.setMat4("view", view);
         skyboxShader.setMat4("projection", projection);
+        skyboxShader.setBool("reverseZ", reversedDepth);
         // skybox cube
         glBindVertexArray(skyboxVAO);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         glBindVertexArray(0);
-        glDepthFunc(GL_LESS); // set depth function back to default
+        glDepthFunc(reversedDepth ? GL_GREATER : GL_LESS); // set depth function back to default
+
+        if (reversedDepth)
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, largeWorldFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, largeWorldWidth, largeWorldHeight, 0, 0, largeWorldWidth, largeWorldHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -460,7 +580,7 @@ int main()
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window, float &planetSpeed, float &cube1Speed, float &cube2Speed, float& cube3Speed, float& cube4Speed, float& cube5Speed, float& cube6Speed, float& planetSpinSpeed, float& cube1SpinSpeed, float& cube2SpinSpeed, float& cube3SpinSpeed, float& cube4SpinSpeed, float& cube5SpinSpeed, float& cube6SpinSpeed, unsigned int& diffuseMap, float& viewX, float& viewY) {
-    static int space_pressed = 0, backspace_pressed = 0;
+    static int space_pressed = 0, backspace_pressed = 0, l_pressed = 0;
     static int texture_loaded = 0, other_texture;
     if (glfwGetKey(window, GLFW_KEY_SPACE) != GLFW_PRESS)
         space_pressed = 0;
@@ -468,6 +588,8 @@ void processInput(GLFWwindow *window, float &planetSpeed, float &cube1Speed, flo
         //cout << "backspace not pressed" << endl;
         backspace_pressed = 0;
     }
+    if (glfwGetKey(window, GLFW_KEY_L) != GLFW_PRESS)
+        l_pressed = 0;
 
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
@@ -497,6 +619,11 @@ void processInput(GLFWwindow *window, float &planetSpeed, float &cube1Speed, flo
         viewY = 0;
     }
 
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS && l_pressed == 0) {
+        largeWorldMode = !largeWorldMode;
+        l_pressed = 1;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_BACKSPACE) == GLFW_PRESS && backspace_pressed == 0) {
         cout << "Change texture" << endl;
         if (texture_loaded == 0) {
@@ -705,4 +832,120 @@ unsigned int loadTexture(char const* path)
     }
 
     return textureID;
-}
\ No newline at end of file
+}
+
+// write a UV sphere .obj of roughly targetBytes, using planet.mtl so it loads like planet.obj
+// --------------------------------------------------------------------------------------------
+void writeSyntheticObj(const string& path, size_t targetBytes)
+{
+    // one v/vt/vn per grid point and two faces per grid cell come to about 440 bytes of text per point
+    int rings = (int)sqrt(targetBytes / 440.0);
+    int segments = rings * 2;
+    ofstream file(path, ios::binary);
+    file << "# synthetic benchmark mesh\nmtllib planet.mtl\no Sphere\n";
+    char line[256];
+    for (int i = 0; i <= rings; i++)
+    {
+        float phi = 3.14159265f * i / rings;
+        for (int j = 0; j <= segments; j++)
+        {
+            float theta = 2.0f * 3.14159265f * j / segments;
+            float x = sin(phi) * cos(theta), y = cos(phi), z = sin(phi) * sin(theta);
+            file.write(line, snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn %f %f %f\n", 2.6f * x, 2.6f * y + 1.05f, 2.6f * z, (float)j / segments, (float)i / rings, x, y, z));
+        }
+    }
+    file << "usemtl Material.001\n";
+    for (int i = 0; i < rings; i++)
+    {
+        for (int j = 0; j < segments; j++)
+        {
+            int a = i * (segments + 1) + j + 1, b = a + 1, c = a + segments + 1, d = c + 1;
+            file.write(line, snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, b, b, b, b, b, b, c, c, c, d, d, d));
+        }
+    }
+}
+
+// time the Assimp Model constructor against ObjLoader (parse only) and ObjModel (parse + upload)
+// on planet.obj and on a synthetic 100 MB mesh; needs a current GL context for the uploads
+// ---------------------------------------------------------------------------------------------
+void benchmarkObjLoaders()
+{
+    string synthetic = FileSystem::getPath("resources/planet/synthetic_benchmark.obj");
+    cout << "Writing " << synthetic << endl;
+    writeSyntheticObj(synthetic, 100 * 1024 * 1024);
+
+    vector<string> paths { FileSystem::getPath("resources/planet/planet.obj"), synthetic };
+    for (unsigned int i = 0; i < paths.size(); i++)
+    {
+        ifstream file(paths[i], ios::binary | ios::ate);
+        double mb = (streamoff)file.tellg() / (1024.0 * 1024.0);
+        cout << paths[i] << " (" << mb << " MB)" << endl;
+
+        auto start = chrono::high_resolution_clock::now();
+        {
+            Model model(paths[i]);
+        }
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        cout << "    Model (Assimp):   " << seconds * 1000.0 << " ms, " << mb / seconds << " MB/s" << endl;
+
+        ObjMeshData data;
+        ObjLoader::Load(paths[i], data);
+        cout << "    ObjLoader parse:  " << data.seconds * 1000.0 << " ms, " << mb / data.seconds << " MB/s, " << data.threads << " threads" << endl;
+
+        start = chrono::high_resolution_clock::now();
+        {
+            ObjModel model(paths[i]);
+        }
+        seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        cout << "    ObjModel (total): " << seconds * 1000.0 << " ms, " << mb / seconds << " MB/s" << endl;
+    }
+    remove(synthetic.c_str());
+}
+
+// look up glClipControl if the context supports it (GL 4.5 or ARB_clip_control)
+// -------------------------------------------------------------------------------
+bool loadClipControl()
+{
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 5) || glfwExtensionSupported("GL_ARB_clip_control"))
+        clipControl = (ClipControlProc)glfwGetProcAddress("glClipControl");
+    return clipControl != NULL;
+}
+
+// perspective projection for a [0, 1] clip depth range with the far plane at infinity:
+// depth is 1 at zNear and goes to 0 far away, which suits the float depth buffer's precision
+// ------------------------------------------------------------------------------------------
+glm::mat4 reverseInfinitePerspective(float fovy, float aspect, float zNear)
+{
+    float f = 1.0f / tan(fovy / 2.0f);
+    glm::mat4 result(0.0f);
+    result[0][0] = f / aspect;
+    result[1][1] = f;
+    result[2][3] = -1.0f;
+    result[3][2] = zNear;
+    return result;
+}
+
+// create (or resize) the offscreen framebuffer with a 32-bit float depth buffer used by large-world mode
+// -------------------------------------------------------------------------------------------------------
+void setupLargeWorldFramebuffer(unsigned int& fbo, unsigned int& colorBuffer, unsigned int& depthBuffer, int width, int height)
+{
+    if (fbo == 0)
+    {
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAMEBUFFER:: Large-world framebuffer is not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
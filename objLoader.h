@@ -0,0 +1,617 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/model.h>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// read-only memory mapping of a whole file
+// ----------------------------------------
+class MappedFile
+{
+public:
+    const char* data = nullptr;
+    size_t size = 0;
+
+    MappedFile(const string& path)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+            return;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+            return;
+        data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data)
+            size = (size_t)fileSize.QuadPart;
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+            return;
+        void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+            return;
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        data = (const char*)p;
+        size = st.st_size;
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (data)
+            munmap((void*)data, size);
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
+
+struct ObjMaterial {
+    string name;
+    string diffuseMap; // map_Kd, relative to the .mtl file
+};
+
+// triangles sharing one material, with their own indexed vertex array
+struct ObjGroup {
+    int material; // index into ObjMeshData::materials, -1 if the faces had no usemtl
+    vector<float> vertices; // position (3), normal (3), texture coords (2) per vertex
+    vector<unsigned int> indices;
+};
+
+struct ObjMeshData {
+    vector<ObjMaterial> materials;
+    vector<ObjGroup> groups;
+    size_t bytes = 0;
+    double seconds = 0.0;
+    unsigned int threads = 0;
+};
+
+// Native OBJ/MTL loader: the file is memory mapped, split into line aligned chunks that are
+// parsed in parallel, and the chunks are merged into one indexed vertex array per material.
+// Texture coordinates are flipped vertically to match the Assimp path (aiProcess_FlipUVs),
+// and smooth normals are generated when the file has none.
+// ---------------------------------------------------------------------------------------------
+class ObjLoader
+{
+public:
+    static bool Load(const string& path, ObjMeshData& out, unsigned int threads = 0)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        out = ObjMeshData();
+        MappedFile file(path);
+        if (!file.data)
+        {
+            cout << "ERROR::OBJLOADER:: could not open " << path << endl;
+            return false;
+        }
+        if (threads == 0)
+            threads = max(1u, thread::hardware_concurrency());
+        // small files are not worth the thread start up
+        size_t chunkCount = min<size_t>(threads, file.size / (256 * 1024) + 1);
+
+        // split into chunks that start right after a newline
+        vector<const char*> bounds(chunkCount + 1);
+        bounds[0] = file.data;
+        bounds[chunkCount] = file.data + file.size;
+        for (size_t i = 1; i < chunkCount; i++)
+        {
+            const char* p = max(bounds[i - 1], file.data + file.size * i / chunkCount);
+            const char* end = file.data + file.size;
+            const char* nl = (const char*)memchr(p, '\n', end - p);
+            bounds[i] = nl ? nl + 1 : end;
+        }
+
+        vector<Chunk> chunks(chunkCount);
+        vector<thread> workers;
+        for (size_t i = 1; i < chunkCount; i++)
+            workers.push_back(thread(ParseChunk, bounds[i], bounds[i + 1], ref(chunks[i])));
+        ParseChunk(bounds[0], bounds[1], chunks[0]);
+        for (unsigned int i = 0; i < workers.size(); i++)
+            workers[i].join();
+
+        Merge(chunks, out);
+
+        string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        for (size_t i = 0; i < chunks.size(); i++)
+            for (size_t j = 0; j < chunks[i].mtllibs.size(); j++)
+                LoadMtl(directory + chunks[i].mtllibs[j], out.materials);
+
+        out.bytes = file.size;
+        out.threads = (unsigned int)chunkCount;
+        out.seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        return true;
+    }
+
+    // parse a float the way strtof would for the plain decimal forms OBJ files use
+    static const char* ParseFloat(const char* p, const char* end, float& out)
+    {
+        static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        while (p < end && (*p == ' ' || *p == '\t'))
+            p++;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+        uint64_t mantissa = 0;
+        int exponent = 0, digits = 0;
+        for (; p < end && (unsigned)(*p - '0') < 10; p++)
+        {
+            if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; }
+            else exponent++;
+        }
+        if (p < end && *p == '.')
+        {
+            for (p++; p < end && (unsigned)(*p - '0') < 10; p++)
+            {
+                if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; exponent--; }
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char* q = p + 1;
+            bool negativeExponent = false;
+            if (q < end && (*q == '-' || *q == '+'))
+                negativeExponent = *q++ == '-';
+            if (q < end && (unsigned)(*q - '0') < 10)
+            {
+                int e = 0;
+                for (; q < end && (unsigned)(*q - '0') < 10; q++)
+                    if (e < 10000) e = e * 10 + (*q - '0');
+                exponent += negativeExponent ? -e : e;
+                p = q;
+            }
+        }
+        double value = (double)mantissa;
+        if (exponent < 0)
+            value = exponent >= -22 ? value / powers[-exponent] : value * pow(10.0, exponent);
+        else if (exponent > 0)
+            value = exponent <= 22 ? value * powers[exponent] : value * pow(10.0, exponent);
+        out = (float)(negative ? -value : value);
+        return p;
+    }
+
+private:
+    // everything parsed from one chunk; face indices are 0-based and -1 when missing
+    struct Chunk {
+        vector<float> positions, texCoords, normals;
+        vector<int> corners; // 3 per triangle corner: position, texture coord, normal
+        vector<size_t> relativeCorners; // slots in corners that came from negative indices
+        vector<pair<size_t, string>> materialSwitches; // first triangle (within the chunk) and usemtl name
+        vector<string> mtllibs;
+    };
+
+    static const char* SkipSpaces(const char* p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t'))
+            p++;
+        return p;
+    }
+
+    static const char* ParseInt(const char* p, const char* end, int& out)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+        int value = 0;
+        for (; p < end && (unsigned)(*p - '0') < 10; p++)
+            value = value * 10 + (*p - '0');
+        out = negative ? -value : value;
+        return p;
+    }
+
+    static string ParseName(const char* p, const char* end)
+    {
+        p = SkipSpaces(p, end);
+        const char* e = p;
+        while (e < end && *e != '\n' && *e != '\r')
+            e++;
+        while (e > p && (e[-1] == ' ' || e[-1] == '\t'))
+            e--;
+        return string(p, e);
+    }
+
+    static void ParseChunk(const char* p, const char* end, Chunk& chunk)
+    {
+        // face corners are collected per face and fanned into triangles
+        vector<int> face;
+        while (p < end)
+        {
+            p = SkipSpaces(p, end);
+            const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+            if (!lineEnd)
+                lineEnd = end;
+            if (p + 1 < lineEnd && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                float x, y, z;
+                p = ParseFloat(p + 1, lineEnd, x);
+                p = ParseFloat(p, lineEnd, y);
+                p = ParseFloat(p, lineEnd, z);
+                chunk.positions.push_back(x);
+                chunk.positions.push_back(y);
+                chunk.positions.push_back(z);
+            }
+            else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+            {
+                float u, v = 0.0f;
+                p = ParseFloat(p + 2, lineEnd, u);
+                p = ParseFloat(p, lineEnd, v);
+                chunk.texCoords.push_back(u);
+                chunk.texCoords.push_back(v);
+            }
+            else if (p + 2 < lineEnd && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+            {
+                float x, y, z;
+                p = ParseFloat(p + 2, lineEnd, x);
+                p = ParseFloat(p, lineEnd, y);
+                p = ParseFloat(p, lineEnd, z);
+                chunk.normals.push_back(x);
+                chunk.normals.push_back(y);
+                chunk.normals.push_back(z);
+            }
+            else if (p + 1 < lineEnd && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                face.clear();
+                p = SkipSpaces(p + 1, lineEnd);
+                while (p < lineEnd && *p != '\r' && *p != '#')
+                {
+                    int index[3] = { 0, 0, 0 };
+                    const char* token = p;
+                    p = ParseInt(p, lineEnd, index[0]);
+                    for (int k = 1; k < 3 && p < lineEnd && *p == '/'; k++)
+                    {
+                        p++;
+                        if (p < lineEnd && *p != '/')
+                            p = ParseInt(p, lineEnd, index[k]);
+                    }
+                    if (p == token)
+                        break; // not an index, ignore the rest of the line
+                    for (int k = 0; k < 3; k++)
+                        face.push_back(index[k]);
+                    p = SkipSpaces(p, lineEnd);
+                }
+                size_t cornerCount = face.size() / 3;
+                for (size_t i = 1; i + 1 < cornerCount; i++)
+                {
+                    AddCorner(chunk, &face[0]);
+                    AddCorner(chunk, &face[i * 3]);
+                    AddCorner(chunk, &face[(i + 1) * 3]);
+                }
+            }
+            else if (lineEnd - p > 7 && strncmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+                chunk.materialSwitches.push_back(make_pair(chunk.corners.size() / 9, ParseName(p + 6, lineEnd)));
+            else if (lineEnd - p > 7 && strncmp(p, "mtllib", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+                chunk.mtllibs.push_back(ParseName(p + 6, lineEnd));
+            p = lineEnd + 1;
+        }
+    }
+
+    // convert OBJ's 1-based (or negative, relative) indices to 0-based ones
+    static void AddCorner(Chunk& chunk, const int* index)
+    {
+        size_t counts[3] = { chunk.positions.size() / 3, chunk.texCoords.size() / 2, chunk.normals.size() / 3 };
+        for (int k = 0; k < 3; k++)
+        {
+            if (index[k] > 0)
+                chunk.corners.push_back(index[k] - 1);
+            else if (index[k] < 0)
+            {
+                // relative to the end of this chunk so far, fixed up once earlier chunks are counted
+                chunk.relativeCorners.push_back(chunk.corners.size());
+                chunk.corners.push_back((int)counts[k] + index[k]);
+            }
+            else
+                chunk.corners.push_back(-1);
+        }
+    }
+
+    static void Merge(vector<Chunk>& chunks, ObjMeshData& out)
+    {
+        vector<float> positions, texCoords, normals;
+        size_t totals[3] = { 0, 0, 0 };
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            Chunk& chunk = chunks[i];
+            for (size_t j = 0; j < chunk.relativeCorners.size(); j++)
+            {
+                size_t slot = chunk.relativeCorners[j];
+                chunk.corners[slot] += (int)totals[slot % 3];
+            }
+            totals[0] += chunk.positions.size() / 3;
+            totals[1] += chunk.texCoords.size() / 2;
+            totals[2] += chunk.normals.size() / 3;
+        }
+        positions.reserve(totals[0] * 3);
+        texCoords.reserve(totals[1] * 2);
+        normals.reserve(totals[2] * 3);
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            positions.insert(positions.end(), chunks[i].positions.begin(), chunks[i].positions.end());
+            texCoords.insert(texCoords.end(), chunks[i].texCoords.begin(), chunks[i].texCoords.end());
+            normals.insert(normals.end(), chunks[i].normals.begin(), chunks[i].normals.end());
+            vector<float>().swap(chunks[i].positions);
+            vector<float>().swap(chunks[i].texCoords);
+            vector<float>().swap(chunks[i].normals);
+        }
+
+        // assign every triangle to a group by the usemtl name active at that point
+        vector<string> names;
+        vector<vector<pair<size_t, size_t>>> ranges; // (chunk, first triangle) .. next switch, per group
+        int current = -1;
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            Chunk& chunk = chunks[i];
+            size_t triangles = chunk.corners.size() / 9;
+            size_t first = 0;
+            for (size_t j = 0; j <= chunk.materialSwitches.size(); j++)
+            {
+                size_t last = j < chunk.materialSwitches.size() ? chunk.materialSwitches[j].first : triangles;
+                if (last > first)
+                {
+                    if (current < 0)
+                    {
+                        current = (int)names.size();
+                        names.push_back("");
+                        ranges.push_back(vector<pair<size_t, size_t>>());
+                    }
+                    ranges[current].push_back(make_pair(i, first));
+                    ranges[current].push_back(make_pair(i, last));
+                }
+                if (j < chunk.materialSwitches.size())
+                {
+                    const string& name = chunk.materialSwitches[j].second;
+                    current = (int)(find(names.begin(), names.end(), name) - names.begin());
+                    if (current == (int)names.size())
+                    {
+                        names.push_back(name);
+                        ranges.push_back(vector<pair<size_t, size_t>>());
+                    }
+                    first = last;
+                }
+            }
+        }
+
+        // smooth normals for files without vn, weighted by triangle area like aiProcess_GenSmoothNormals
+        vector<float> generatedNormals;
+        bool hasNormals = !normals.empty();
+        if (!hasNormals)
+        {
+            generatedNormals.assign(positions.size(), 0.0f);
+            for (size_t i = 0; i < chunks.size(); i++)
+            {
+                const vector<int>& c = chunks[i].corners;
+                for (size_t t = 0; t + 8 < c.size(); t += 9)
+                {
+                    if (!ValidIndex(c[t], totals[0]) || !ValidIndex(c[t + 3], totals[0]) || !ValidIndex(c[t + 6], totals[0]))
+                        continue;
+                    glm::vec3 a(positions[c[t] * 3], positions[c[t] * 3 + 1], positions[c[t] * 3 + 2]);
+                    glm::vec3 b(positions[c[t + 3] * 3], positions[c[t + 3] * 3 + 1], positions[c[t + 3] * 3 + 2]);
+                    glm::vec3 d(positions[c[t + 6] * 3], positions[c[t + 6] * 3 + 1], positions[c[t + 6] * 3 + 2]);
+                    glm::vec3 n = glm::cross(b - a, d - a);
+                    for (int k = 0; k < 9; k += 3)
+                        for (int j = 0; j < 3; j++)
+                            generatedNormals[c[t + k] * 3 + j] += n[j];
+                }
+            }
+            for (size_t i = 0; i < generatedNormals.size(); i += 3)
+            {
+                glm::vec3 n(generatedNormals[i], generatedNormals[i + 1], generatedNormals[i + 2]);
+                float length = glm::length(n);
+                if (length > 0.0f)
+                    n /= length;
+                generatedNormals[i] = n.x;
+                generatedNormals[i + 1] = n.y;
+                generatedNormals[i + 2] = n.z;
+            }
+        }
+
+        // build indexed vertices per group; identical (position, texcoord, normal) corners share a vertex,
+        // found through a chain of vertices per position index
+        vector<int> firstVertex(totals[0], -1);
+        vector<int> nextVertex;
+        vector<int> vertexKeys; // texture coord and normal index of each vertex in the group
+        for (size_t g = 0; g < names.size(); g++)
+        {
+            ObjGroup group;
+            group.material = -1;
+            group.vertices.reserve(totals[0] * 8 / names.size());
+            nextVertex.clear();
+            vertexKeys.clear();
+            vector<int> touched;
+            for (size_t r = 0; r + 1 < ranges[g].size(); r += 2)
+            {
+                const vector<int>& c = chunks[ranges[g][r].first].corners;
+                for (size_t t = ranges[g][r].second * 9; t < ranges[g][r + 1].second * 9; t += 9)
+                {
+                    if (!ValidIndex(c[t], totals[0]) || !ValidIndex(c[t + 3], totals[0]) || !ValidIndex(c[t + 6], totals[0]))
+                        continue;
+                    for (int k = 0; k < 9; k += 3)
+                    {
+                        int position = c[t + k];
+                        int texCoord = ValidIndex(c[t + k + 1], totals[1]) ? c[t + k + 1] : -1;
+                        int normal = hasNormals ? (ValidIndex(c[t + k + 2], totals[2]) ? c[t + k + 2] : -1) : position;
+                        int vertex = firstVertex[position];
+                        while (vertex >= 0 && (vertexKeys[vertex * 2] != texCoord || vertexKeys[vertex * 2 + 1] != normal))
+                            vertex = nextVertex[vertex];
+                        if (vertex < 0)
+                        {
+                            vertex = (int)nextVertex.size();
+                            if (firstVertex[position] < 0)
+                                touched.push_back(position);
+                            nextVertex.push_back(firstVertex[position]);
+                            firstVertex[position] = vertex;
+                            vertexKeys.push_back(texCoord);
+                            vertexKeys.push_back(normal);
+                            const float* n = normal < 0 ? nullptr : hasNormals ? &normals[normal * 3] : &generatedNormals[normal * 3];
+                            group.vertices.insert(group.vertices.end(), {
+                                positions[position * 3], positions[position * 3 + 1], positions[position * 3 + 2],
+                                n ? n[0] : 0.0f, n ? n[1] : 0.0f, n ? n[2] : 0.0f,
+                                texCoord < 0 ? 0.0f : texCoords[texCoord * 2], texCoord < 0 ? 0.0f : 1.0f - texCoords[texCoord * 2 + 1] });
+                        }
+                        group.indices.push_back((unsigned int)vertex);
+                    }
+                }
+            }
+            for (size_t i = 0; i < touched.size(); i++)
+                firstVertex[touched[i]] = -1;
+            if (group.indices.empty())
+                continue;
+            if (!names[g].empty())
+            {
+                group.material = (int)out.materials.size();
+                out.materials.push_back(ObjMaterial());
+                out.materials.back().name = names[g];
+            }
+            out.groups.push_back(std::move(group));
+        }
+    }
+
+    static bool ValidIndex(int index, size_t count)
+    {
+        return index >= 0 && (size_t)index < count;
+    }
+
+    // read newmtl / map_Kd from a .mtl file, filling in materials that are already referenced by name
+    static void LoadMtl(const string& path, vector<ObjMaterial>& materials)
+    {
+        ifstream file(path);
+        if (!file)
+        {
+            cout << "ERROR::OBJLOADER:: could not open material library " << path << endl;
+            return;
+        }
+        string line, current;
+        while (getline(file, line))
+        {
+            const char* p = SkipSpaces(line.c_str(), line.c_str() + line.size());
+            const char* end = line.c_str() + line.size();
+            if (strncmp(p, "newmtl", 6) == 0)
+                current = ParseName(p + 6, end);
+            else if (strncmp(p, "map_Kd", 6) == 0)
+            {
+                // options such as -s or -o come before the file name, which is the last token
+                string value = ParseName(p + 6, end);
+                size_t space = value.find_last_of(" \t");
+                if (space != string::npos)
+                    value = value.substr(space + 1);
+                for (size_t i = 0; i < materials.size(); i++)
+                    if (materials[i].name == current)
+                        materials[i].diffuseMap = value;
+            }
+        }
+    }
+};
+
+// Drawable model built from ObjLoader, a drop-in for Model when loading .obj files
+// ---------------------------------------------------------------------------------
+class ObjModel
+{
+public:
+    vector<Texture> textures_loaded;
+    vector<Mesh> meshes;
+    string directory;
+
+    ObjModel(string const& path, bool gamma = false) : gammaCorrection(gamma)
+    {
+        directory = path.substr(0, path.find_last_of("/\\"));
+        ObjMeshData data;
+        if (!ObjLoader::Load(path, data))
+            return;
+        double mb = data.bytes / (1024.0 * 1024.0);
+        cout << "Parsed " << path << ": " << mb << " MB in " << data.seconds * 1000.0 << " ms ("
+             << mb / data.seconds << " MB/s, " << data.threads << " threads)" << endl;
+
+        for (unsigned int i = 0; i < data.groups.size(); i++)
+        {
+            const ObjGroup& group = data.groups[i];
+            vector<Vertex> vertices(group.vertices.size() / 8);
+            for (unsigned int v = 0; v < vertices.size(); v++)
+            {
+                const float* f = &group.vertices[v * 8];
+                vertices[v].Position = glm::vec3(f[0], f[1], f[2]);
+                vertices[v].Normal = glm::vec3(f[3], f[4], f[5]);
+                vertices[v].TexCoords = glm::vec2(f[6], f[7]);
+            }
+            vector<Texture> textures;
+            if (group.material >= 0 && !data.materials[group.material].diffuseMap.empty())
+                textures.push_back(loadDiffuseTexture(data.materials[group.material].diffuseMap));
+            meshes.push_back(Mesh(vertices, group.indices, textures));
+        }
+    }
+
+    void Draw(Shader& shader)
+    {
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader);
+    }
+
+private:
+    bool gammaCorrection;
+
+    // textures are shared between meshes the same way Model::loadMaterialTextures does it
+    Texture loadDiffuseTexture(const string& path)
+    {
+        for (unsigned int i = 0; i < textures_loaded.size(); i++)
+            if (textures_loaded[i].path == path)
+                return textures_loaded[i];
+        Texture texture;
+        texture.id = TextureFromFile(path.c_str(), directory, gammaCorrection);
+        texture.type = "texture_diffuse";
+        texture.path = path;
+        textures_loaded.push_back(texture);
+        return texture;
+    }
+};
+#endif
@@ -0,0 +1,393 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE2
+#endif
+
+using namespace std;
+
+// Software occlusion culler: rasterizes low-poly occluder proxies into a small CPU depth
+// buffer, builds a min/max hierarchy over it and tests screen-space bounding boxes against it.
+// With the classic [-w, w] clip range depth is NDC z remapped to [0,1], smaller is closer.
+// With the reversed-Z [0, w] range used by large-world mode depth is NDC z itself, larger is
+// closer, so far away bodies keep the float precision reverse-Z gives them.
+// ----------------------------------------------------------------------------------------------
+class OcclusionCuller
+{
+public:
+    // tiles are TILE_SIZE x TILE_SIZE pixels, coarse tiles are COARSE_TILES x COARSE_TILES tiles
+    static const int TILE_SIZE = 8;
+    static const int COARSE_TILES = 4;
+
+    // width and height must be multiples of TILE_SIZE (and width of 4 for the SIMD rows)
+    OcclusionCuller(int width = 256, int height = 192)
+        : Width(width), Height(height), TilesX(width / TILE_SIZE), TilesY(height / TILE_SIZE),
+          CoarseX((TilesX + COARSE_TILES - 1) / COARSE_TILES), CoarseY((TilesY + COARSE_TILES - 1) / COARSE_TILES),
+          depth(width * height), tileNear(TilesX * TilesY), tileFar(TilesX * TilesY), coarseFar(CoarseX * CoarseY)
+    {
+    }
+
+    // clear the depth buffer and set the view-projection matrix used by the rest of the frame
+    void BeginFrame(const glm::mat4& viewProjection, bool reversedZ = false)
+    {
+        viewProj = viewProjection;
+        reversed = reversedZ;
+        std::fill(depth.begin(), depth.end(), FarDepth());
+    }
+
+    // rasterize a convex proxy given as an indexed triangle list in object space, where model is
+    // made of rotation, uniform scale and translation. Pixels are sampled at their centers and one
+    // culler pixel spans several window pixels, so the proxy is first shrunk towards its center until
+    // its silhouette moves in by SHRINK_PIXELS: a partly covered pixel then never hides geometry the
+    // GPU still draws, and the surface moves back so the stored depth stays behind the real one.
+    // Triangles crossing the near plane are skipped. Both only make the occluder smaller, so a
+    // visible object is never culled.
+    void RenderOccluder(const glm::mat4& model, const vector<glm::vec3>& vertices, const vector<unsigned int>& indices)
+    {
+        glm::mat4 mvp = viewProj * model;
+
+        // center, inradius and circumradius of the proxy in object space
+        glm::vec3 lo = vertices[0], hi = vertices[0];
+        for (unsigned int i = 1; i < vertices.size(); i++)
+        {
+            lo = glm::vec3(std::min(lo.x, vertices[i].x), std::min(lo.y, vertices[i].y), std::min(lo.z, vertices[i].z));
+            hi = glm::vec3(std::max(hi.x, vertices[i].x), std::max(hi.y, vertices[i].y), std::max(hi.z, vertices[i].z));
+        }
+        glm::vec3 center = 0.5f * (lo + hi);
+        float inradius = 1e30f, circumradius = 0.0f;
+        for (unsigned int i = 0; i < vertices.size(); i++)
+            circumradius = std::max(circumradius, glm::length(vertices[i] - center));
+        for (unsigned int i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const glm::vec3& a = vertices[indices[i]];
+            glm::vec3 n = glm::cross(vertices[indices[i + 1]] - a, vertices[indices[i + 2]] - a);
+            float length = glm::length(n);
+            if (length > 0.0f)
+                inradius = std::min(inradius, std::fabs(glm::dot(n, a - center)) / length);
+        }
+
+        // a shift of d object units perpendicular to the view ray at view depth w moves at least
+        // d * pixelsPerUnit / w pixels; size it for the farthest point of the proxy
+        glm::vec3 rowX(mvp[0][0], mvp[1][0], mvp[2][0]), rowY(mvp[0][1], mvp[1][1], mvp[2][1]), rowW(mvp[0][3], mvp[1][3], mvp[2][3]);
+        float pixelsPerUnit = std::min(glm::length(rowX) * Width, glm::length(rowY) * Height) * 0.5f;
+        float farthestW = (mvp * glm::vec4(center, 1.0f)).w + glm::length(rowW) * circumradius;
+        float shrink = 1.0f - SHRINK_PIXELS * farthestW / (inradius * pixelsPerUnit);
+        if (!(shrink > 0.0f))
+            return; // too small on screen to hide anything safely
+
+        screen.resize(vertices.size());
+        for (unsigned int i = 0; i < vertices.size(); i++)
+        {
+            glm::vec4 clip = mvp * glm::vec4(center + shrink * (vertices[i] - center), 1.0f);
+            if (BeforeNearPlane(clip))
+            {
+                screen[i] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+                continue;
+            }
+            float invW = 1.0f / clip.w;
+            screen[i] = glm::vec4((clip.x * invW * 0.5f + 0.5f) * Width,
+                                  (clip.y * invW * 0.5f + 0.5f) * Height,
+                                  ToDepth(clip, invW), 1.0f);
+        }
+        for (unsigned int i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const glm::vec4& a = screen[indices[i]];
+            const glm::vec4& b = screen[indices[i + 1]];
+            const glm::vec4& c = screen[indices[i + 2]];
+            if (a.w < 0.0f || b.w < 0.0f || c.w < 0.0f)
+                continue;
+            RasterizeTriangle(a, b, c);
+        }
+    }
+
+    // build per-tile nearest/farthest depth and the coarse farthest level from the depth buffer
+    void BuildHierarchy()
+    {
+        for (int ty = 0; ty < TilesY; ty++)
+        {
+            for (int tx = 0; tx < TilesX; tx++)
+            {
+                const float* row = &depth[(ty * TILE_SIZE) * Width + tx * TILE_SIZE];
+#ifdef OCCLUSION_CULLER_SSE2
+                __m128 mn = _mm_set1_ps(1.0f), mx = _mm_setzero_ps();
+                for (int y = 0; y < TILE_SIZE; y++, row += Width)
+                {
+                    for (int x = 0; x < TILE_SIZE; x += 4)
+                    {
+                        __m128 d = _mm_loadu_ps(row + x);
+                        mn = _mm_min_ps(mn, d);
+                        mx = _mm_max_ps(mx, d);
+                    }
+                }
+                tileNear[ty * TilesX + tx] = reversed ? HorizontalMax(mx) : HorizontalMin(mn);
+                tileFar[ty * TilesX + tx] = reversed ? HorizontalMin(mn) : HorizontalMax(mx);
+#else
+                float mn = 1.0f, mx = 0.0f;
+                for (int y = 0; y < TILE_SIZE; y++, row += Width)
+                {
+                    for (int x = 0; x < TILE_SIZE; x++)
+                    {
+                        mn = std::min(mn, row[x]);
+                        mx = std::max(mx, row[x]);
+                    }
+                }
+                tileNear[ty * TilesX + tx] = reversed ? mx : mn;
+                tileFar[ty * TilesX + tx] = reversed ? mn : mx;
+#endif
+            }
+        }
+        for (int cy = 0; cy < CoarseY; cy++)
+        {
+            for (int cx = 0; cx < CoarseX; cx++)
+            {
+                float farthest = 1.0f - FarDepth(); // start at the near end of the range
+                for (int ty = cy * COARSE_TILES; ty < std::min(TilesY, (cy + 1) * COARSE_TILES); ty++)
+                    for (int tx = cx * COARSE_TILES; tx < std::min(TilesX, (cx + 1) * COARSE_TILES); tx++)
+                        if (Closer(farthest, tileFar[ty * TilesX + tx]))
+                            farthest = tileFar[ty * TilesX + tx];
+                coarseFar[cy * CoarseX + cx] = farthest;
+            }
+        }
+    }
+
+    // returns true if the object space box [boxMin, boxMax] is completely hidden behind the occluders
+    bool IsOccluded(const glm::mat4& model, const glm::vec3& boxMin, const glm::vec3& boxMax) const
+    {
+        glm::mat4 mvp = viewProj * model;
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = FarDepth();
+        for (int i = 0; i < 8; i++)
+        {
+            glm::vec4 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z, 1.0f);
+            glm::vec4 clip = mvp * corner;
+            if (BeforeNearPlane(clip))
+                return false; // box touches the near plane, keep it
+            float invW = 1.0f / clip.w;
+            float sx = (clip.x * invW * 0.5f + 0.5f) * Width;
+            float sy = (clip.y * invW * 0.5f + 0.5f) * Height;
+            minX = std::min(minX, sx);
+            maxX = std::max(maxX, sx);
+            minY = std::min(minY, sy);
+            maxY = std::max(maxY, sy);
+            float d = ToDepth(clip, invW);
+            if (Closer(d, nearest))
+                nearest = d;
+        }
+        // off-screen boxes are left to the GPU's own clipping
+        if (maxX < 0.0f || maxY < 0.0f || minX >= Width || minY >= Height)
+            return false;
+        int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(Width - 1, (int)std::floor(maxX));
+        int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(Height - 1, (int)std::floor(maxY));
+
+        for (int cy = y0 / (TILE_SIZE * COARSE_TILES); cy <= y1 / (TILE_SIZE * COARSE_TILES); cy++)
+        {
+            for (int cx = x0 / (TILE_SIZE * COARSE_TILES); cx <= x1 / (TILE_SIZE * COARSE_TILES); cx++)
+            {
+                // everything under this coarse tile is closer than the box
+                if (Closer(coarseFar[cy * CoarseX + cx], nearest))
+                    continue;
+                int tx0 = std::max(x0 / TILE_SIZE, cx * COARSE_TILES), tx1 = std::min(x1 / TILE_SIZE, cx * COARSE_TILES + COARSE_TILES - 1);
+                int ty0 = std::max(y0 / TILE_SIZE, cy * COARSE_TILES), ty1 = std::min(y1 / TILE_SIZE, cy * COARSE_TILES + COARSE_TILES - 1);
+                for (int ty = ty0; ty <= ty1; ty++)
+                {
+                    for (int tx = tx0; tx <= tx1; tx++)
+                    {
+                        if (Closer(tileFar[ty * TilesX + tx], nearest))
+                            continue;
+                        // nothing in this tile is in front of the box
+                        if (!Closer(tileNear[ty * TilesX + tx], nearest))
+                            return false;
+                        // tile is partially covered, check the overlapped pixels
+                        int px0 = std::max(x0, tx * TILE_SIZE), px1 = std::min(x1, tx * TILE_SIZE + TILE_SIZE - 1);
+                        int py0 = std::max(y0, ty * TILE_SIZE), py1 = std::min(y1, ty * TILE_SIZE + TILE_SIZE - 1);
+                        for (int py = py0; py <= py1; py++)
+                            for (int px = px0; px <= px1; px++)
+                                if (!Closer(depth[py * Width + px], nearest))
+                                    return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    // build a coarse UV sphere whose triangles lie inside the sphere, so it is a conservative occluder
+    static void MakeSphereProxy(const glm::vec3& center, float radius, int slices, int stacks, vector<glm::vec3>& vertices, vector<unsigned int>& indices)
+    {
+        vertices.clear();
+        indices.clear();
+        for (int i = 0; i <= stacks; i++)
+        {
+            float phi = 3.14159265f * i / stacks;
+            for (int j = 0; j < slices; j++)
+            {
+                float theta = 2.0f * 3.14159265f * j / slices;
+                vertices.push_back(center + radius * glm::vec3(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta)));
+            }
+        }
+        for (int i = 0; i < stacks; i++)
+        {
+            for (int j = 0; j < slices; j++)
+            {
+                unsigned int a = i * slices + j, b = i * slices + (j + 1) % slices;
+                unsigned int c = a + slices, d = b + slices;
+                indices.push_back(a); indices.push_back(c); indices.push_back(b);
+                indices.push_back(b); indices.push_back(c); indices.push_back(d);
+            }
+        }
+    }
+
+    // build an axis aligned box as 12 triangles
+    static void MakeBoxProxy(const glm::vec3& boxMin, const glm::vec3& boxMax, vector<glm::vec3>& vertices, vector<unsigned int>& indices)
+    {
+        vertices.clear();
+        for (int i = 0; i < 8; i++)
+            vertices.push_back(glm::vec3((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z));
+        unsigned int boxIndices[] = {
+            0, 2, 1,  1, 2, 3, // -z
+            4, 5, 6,  5, 7, 6, // +z
+            0, 4, 2,  2, 4, 6, // -x
+            1, 3, 5,  3, 7, 5, // +x
+            0, 1, 4,  1, 5, 4, // -y
+            2, 6, 3,  3, 6, 7  // +y
+        };
+        indices.assign(boxIndices, boxIndices + 36);
+    }
+
+    int Width, Height;
+
+private:
+    static constexpr float NEAR_W = 1e-4f;
+    // a pixel center can be up to sqrt(2) / 2 pixels from the pixel's corners
+    static constexpr float SHRINK_PIXELS = 1.0f;
+
+    int TilesX, TilesY, CoarseX, CoarseY;
+    glm::mat4 viewProj;
+    bool reversed = false;
+    vector<float> depth;
+    vector<float> tileNear, tileFar, coarseFar;
+    vector<glm::vec4> screen;
+
+    // true for points the GPU clips away at the near plane, or that are behind the camera
+    bool BeforeNearPlane(const glm::vec4& clip) const
+    {
+        return clip.w <= NEAR_W || (reversed ? clip.z > clip.w : clip.z < -clip.w);
+    }
+
+    float ToDepth(const glm::vec4& clip, float invW) const
+    {
+        return reversed ? clip.z * invW : clip.z * invW * 0.5f + 0.5f;
+    }
+
+    float FarDepth() const
+    {
+        return reversed ? 0.0f : 1.0f;
+    }
+
+    // true if depth a is strictly closer to the camera than depth b
+    bool Closer(float a, float b) const
+    {
+        return reversed ? a > b : a < b;
+    }
+
+    // rasterize one screen space triangle (x, y in pixels, z in [0,1]) with a closer depth test,
+    // sampling at pixel centers and processing four pixels of a row at a time
+    void RasterizeTriangle(glm::vec4 a, glm::vec4 b, glm::vec4 c)
+    {
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::fabs(area) < 1e-8f)
+            return;
+        if (area < 0.0f)
+        {
+            std::swap(b, c); // make the winding consistent so inside means all edges positive
+            area = -area;
+        }
+        int x0 = std::max(0, (int)std::floor(std::min(a.x, std::min(b.x, c.x))));
+        int x1 = std::min(Width - 1, (int)std::ceil(std::max(a.x, std::max(b.x, c.x))));
+        int y0 = std::max(0, (int)std::floor(std::min(a.y, std::min(b.y, c.y))));
+        int y1 = std::min(Height - 1, (int)std::ceil(std::max(a.y, std::max(b.y, c.y))));
+        if (x0 > x1 || y0 > y1)
+            return;
+        x0 &= ~3; // start on a 4 pixel boundary, Width is a multiple of 4
+
+        // edge functions e(x, y) = A * x + B * y + C, positive inside
+        float A0 = b.y - c.y, B0 = c.x - b.x, C0 = b.x * c.y - b.y * c.x; // opposite a
+        float A1 = c.y - a.y, B1 = a.x - c.x, C1 = c.x * a.y - c.y * a.x; // opposite b
+        float A2 = a.y - b.y, B2 = b.x - a.x, C2 = a.x * b.y - a.y * b.x; // opposite c
+        // depth is affine in screen space: z = a.z + dzdx * (x - a.x) + dzdy * (y - a.y)
+        float invArea = 1.0f / area;
+        float dzdx = (A0 * a.z + A1 * b.z + A2 * c.z) * invArea;
+        float dzdy = (B0 * a.z + B1 * b.z + B2 * c.z) * invArea;
+        float z0 = a.z - dzdx * a.x - dzdy * a.y;
+
+#ifdef OCCLUSION_CULLER_SSE2
+        __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        __m128 stepE0 = _mm_set1_ps(A0 * 4.0f), stepE1 = _mm_set1_ps(A1 * 4.0f), stepE2 = _mm_set1_ps(A2 * 4.0f);
+        __m128 stepZ = _mm_set1_ps(dzdx * 4.0f);
+        __m128 zero = _mm_setzero_ps();
+        for (int y = y0; y <= y1; y++)
+        {
+            float py = y + 0.5f;
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x0), offsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A0), px), _mm_set1_ps(B0 * py + C0));
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A1), px), _mm_set1_ps(B1 * py + C1));
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A2), px), _mm_set1_ps(B2 * py + C2));
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(dzdy * py + z0));
+            float* row = &depth[y * Width];
+            for (int x = x0; x <= x1; x += 4)
+            {
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside))
+                {
+                    __m128 old = _mm_loadu_ps(row + x);
+                    __m128 closer = reversed ? _mm_max_ps(old, z) : _mm_min_ps(old, z);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, old)));
+                }
+                e0 = _mm_add_ps(e0, stepE0);
+                e1 = _mm_add_ps(e1, stepE1);
+                e2 = _mm_add_ps(e2, stepE2);
+                z = _mm_add_ps(z, stepZ);
+            }
+        }
+#else
+        for (int y = y0; y <= y1; y++)
+        {
+            float py = y + 0.5f;
+            float* row = &depth[y * Width];
+            for (int x = x0; x <= x1; x++)
+            {
+                float px = x + 0.5f;
+                if (A0 * px + B0 * py + C0 >= 0.0f && A1 * px + B1 * py + C1 >= 0.0f && A2 * px + B2 * py + C2 >= 0.0f)
+                {
+                    float z = dzdx * px + dzdy * py + z0;
+                    if (Closer(z, row[x]))
+                        row[x] = z;
+                }
+            }
+        }
+#endif
+    }
+
+#ifdef OCCLUSION_CULLER_SSE2
+    static float HorizontalMin(__m128 v)
+    {
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(v);
+    }
+    static float HorizontalMax(__m128 v)
+    {
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(v);
+    }
+#endif
+};
+#endif
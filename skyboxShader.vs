@@ -5,10 +5,12 @@ out vec3 TexCoords;
 
 uniform mat4 projection;
 uniform mat4 view;
+uniform bool reverseZ;
 
 void main()
 {
     TexCoords = aPos;
     vec4 pos = projection * view * vec4(aPos, 1.0);
-    gl_Position = pos.xyww;
+    // put the skybox on the far plane, which is depth 0 with reverse-Z
+    gl_Position = reverseZ ? vec4(pos.xy, 0.0, pos.w) : pos.xyww;
 }  
\ No newline at end of file